@@ -71,6 +71,21 @@ void *memcpy(void *dst, const void *src, size_t n) {
   return dst;
 }
 
+void *memmove(void *dst, const void *src, size_t n) { // overlap-safe memcpy
+  uint8_t *d = (uint8_t *)dst;
+  const uint8_t *s = (const uint8_t *)src;
+  if (d <= s) {
+    while (n--)
+      *d++ = *s++;
+  } else { // copy backwards so the source isn't overwritten before it's read
+    d += n;
+    s += n;
+    while (n--)
+      *--d = *--s;
+  }
+  return dst;
+}
+
 void *memset(void *buf, char c, size_t n) { // fill entire buffer with char c
   uint8_t *p = (uint8_t *)buf;
   while (n--)
@@ -87,11 +102,53 @@ char *strcpy(char *dst, const char *src) {
   return dst;
 }
 
+// Word-at-a-time helpers: a 32-bit word contains a zero byte iff
+// (w - 0x01010101) & ~w & 0x80808080 is non-zero. Aligned word loads never
+// cross a page boundary, so reading a few bytes past the terminator is safe.
+typedef uint32_t __attribute__((may_alias)) word_t;
+#define ONES 0x01010101u
+#define HIGHS 0x80808080u
+#define HAS_ZERO(w) (((w) - ONES) & ~(w) & HIGHS)
+
+size_t strlen(const char *s) {
+  const char *p = s;
+  while (!is_aligned(p, 4)) { // byte steps until word aligned
+    if (!*p)
+      return p - s;
+    p++;
+  }
+
+  const word_t *w = (const word_t *)p;
+  while (!HAS_ZERO(*w))
+    w++;
+
+  p = (const char *)w;
+  while (*p) // locate the NULL inside the last word
+    p++;
+  return p - s;
+}
+
 int strcmp(const char *s1, const char *s2) {
-  while (*s1 && *s2) { // until either NULL
-    if (*s1 != *s2) {
-      break;
+  // Words can only be compared if both strings share the same alignment
+  if ((((vaddr_t)s1 ^ (vaddr_t)s2) & 3) == 0) {
+    while (!is_aligned(s1, 4) && *s1 && *s1 == *s2) {
+      s1++;
+      s2++;
+    }
+
+    if (is_aligned(s1, 4)) {
+      const word_t *w1 = (const word_t *)s1;
+      const word_t *w2 = (const word_t *)s2;
+      while (*w1 == *w2 && !HAS_ZERO(*w1)) {
+        w1++;
+        w2++;
+      }
+      s1 = (const char *)w1;
+      s2 = (const char *)w2;
     }
+  }
+
+  while (*s1 && *s1 == *s2) { // until either NULL or mismatch
     s1++;
     s2++;
   }
@@ -100,17 +157,63 @@ int strcmp(const char *s1, const char *s2) {
 }
 
 int strncmp(const char *s1, const char *s2, size_t n) {
-  while (n-- > 0 && *s1 && *s2) {
-    if (*s1 != *s2) {
-      break;
+  if ((((vaddr_t)s1 ^ (vaddr_t)s2) & 3) == 0) {
+    while (n > 0 && !is_aligned(s1, 4) && *s1 && *s1 == *s2) {
+      s1++;
+      s2++;
+      n--;
     }
+
+    if (is_aligned(s1, 4)) {
+      const word_t *w1 = (const word_t *)s1;
+      const word_t *w2 = (const word_t *)s2;
+      while (n >= 4 && *w1 == *w2 && !HAS_ZERO(*w1)) {
+        w1++;
+        w2++;
+        n -= 4;
+      }
+      s1 = (const char *)w1;
+      s2 = (const char *)w2;
+    }
+  }
+
+  while (n > 0 && *s1 && *s1 == *s2) {
     s1++;
     s2++;
+    n--;
   }
 
-  if (n == (size_t)-1) {
+  if (n == 0) {
     return 0;
   }
 
   return *(unsigned char *)s1 - *(unsigned char *)s2;
 }
+
+void *memchr(const void *buf, int c, size_t n) {
+  const uint8_t *p = (const uint8_t *)buf;
+  uint8_t ch = (uint8_t)c;
+  while (n > 0 && !is_aligned(p, 4)) {
+    if (*p == ch)
+      return (void *)p;
+    p++;
+    n--;
+  }
+
+  // XOR with ch in every byte turns a matching byte into a zero byte
+  uint32_t pattern = ch * ONES;
+  const word_t *w = (const word_t *)p;
+  while (n >= 4 && !HAS_ZERO(*w ^ pattern)) {
+    w++;
+    n -= 4;
+  }
+
+  p = (const uint8_t *)w;
+  while (n > 0) {
+    if (*p == ch)
+      return (void *)p;
+    p++;
+    n--;
+  }
+  return NULL;
+}
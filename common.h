@@ -12,7 +12,8 @@ typedef uint32_t vaddr_t; /* representing virtual mem addr - uintptr_t */
 #define true 1
 #define false 0
 #define NULL ((void *)0)
-#define align_up(value, align) __builin_align_up(value, align)
+#define align_up(value, align) __builtin_align_up(value, align)
+#define align_down(value, align) __builtin_align_down(value, align)
 #define is_aligned(value, align) __builtin_is_aligned(value, align)
 #define offsetof(type, member) __builtin_offsetof(type, member)
 
@@ -25,11 +26,45 @@ typedef uint32_t vaddr_t; /* representing virtual mem addr - uintptr_t */
 
 void *memset(void *buf, char c, size_t n);
 void *memcpy(void *dst, const void *src, size_t n);
+void *memmove(void *dst, const void *src, size_t n);
 char *strcpy(char *dst, const char *src);
 int strcmp(const char *s1, const char *s2);
 int strncmp(const char *s1, const char *s2, size_t n);
+size_t strlen(const char *s);
+void *memchr(const void *buf, int c, size_t n);
 void printf(const char *fmt, ...);
 
 #define SYS_PUTCHAR 1
 #define SYS_GETCHAR 2
 #define SYS_EXIT 3
+#define SYS_READ 4
+#define SYS_CONSOLE_MODE 5
+#define SYS_YIELD 6
+#define SYS_PROC_STAT 7
+#define SYS_SPAWN 8
+#define SYS_MAX 9 // one past the highest syscall number
+
+#define CONSOLE_ECHO (1 << 0) // echo input characters back
+#define CONSOLE_LINE (1 << 1) // read returns at most one line
+
+#define PROCS_MAX 8 // Maximum number of processes
+
+#define PROC_UNUSED 0   // Unused process control structure
+#define PROC_RUNNABLE 1 // Runnable process
+#define PROC_EXITED 2   // Exited process
+
+// Per-process resource counters, kept by the kernel
+struct proc_usage {
+  uint64_t cycles;             // CPU cycles spent running
+  uint32_t syscalls[SYS_MAX];  // syscalls issued, by number
+  uint32_t page_faults;        // page faults taken
+  uint32_t resident_pages;     // user pages mapped
+};
+
+// Filled in by SYS_PROC_STAT for one process slot
+struct proc_stat {
+  int pid;
+  int state;
+  uint32_t kstack_peak; // deepest kernel stack use so far, in bytes
+  struct proc_usage usage;
+};
@@ -0,0 +1,3 @@
+#include "user.h"
+
+void main(void) { printf("Hello World from a spawned process!\n"); }
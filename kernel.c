@@ -9,7 +9,9 @@ extern char __bss[], __bss_end[], __stack_top[], __free_ram[], __free_ram_end[],
 // The base virtual address of an application image. This needs to match the
 // starting address defined in `user.ld`.
 #define USER_BASE 0x1000000
-extern char _binary_shell_bin_start[], _binary_shell_bin_size[];
+#define USER_END 0x1800000 // end of the user region - matches the user.ld limit
+extern char __programs[],
+    __programs_end[]; // struct program_archive generated by run.sh
 
 struct sbiret sbi_call(long arg0, long arg1, long arg2, long arg3, long arg4,
                        long arg5, long fid, long eid) {
@@ -41,7 +43,23 @@ long getchar(void) {
   return ret.error; // -1 if no input
 }
 
+paddr_t free_pages; // freed single pages, linked through their first word
+
+// Return a page from alloc_pages(1) for reuse. Only user data, bss and stack
+// pages are freed, when a process slot is recycled.
+void free_page(paddr_t paddr) {
+  *(paddr_t *)paddr = free_pages;
+  free_pages = paddr;
+}
+
 paddr_t alloc_pages(uint32_t n) {
+  if (n == 1 && free_pages) { // recycle a freed page first
+    paddr_t paddr = free_pages;
+    free_pages = *(paddr_t *)paddr;
+    memset((void *)paddr, 0, PAGE_SIZE);
+    return paddr;
+  }
+
   static paddr_t next_paddr =
       (paddr_t)__free_ram; // value retained - initialized only once - allocate
                            // sequentially starting from __free_ram
@@ -58,6 +76,15 @@ paddr_t alloc_pages(uint32_t n) {
   return paddr;
 }
 
+uint64_t read_cycles(void) {
+  uint32_t hi, lo;
+  do { // re-read if the low word wrapped in between
+    hi = READ_CSR(cycleh);
+    lo = READ_CSR(cycle);
+  } while (hi != READ_CSR(cycleh));
+  return ((uint64_t)hi << 32) | lo;
+}
+
 void map_page(uint32_t *table1, vaddr_t vaddr, paddr_t paddr, uint32_t flags) {
   if (!is_aligned(vaddr, PAGE_SIZE)) { // TODO: revisit
     PANIC("unaligned vaddr %x", vaddr);
@@ -95,7 +122,7 @@ __attribute__((naked)) void user_entry(void) {
       "csrw sstatus, %[sstatus]  \n"
       "sret                      \n" // jumps to sepc - switches to U-mode
       :
-      : [sepc] "r"(USER_BASE), [sstatus] "r"(SSTATUS_SPIE));
+      : [sepc] "r"(USER_BASE), [sstatus] "r"(SSTATUS_SPIE | SSTATUS_SUM));
 }
 
 __attribute__((naked)) __attribute__((aligned(4))) void
@@ -237,24 +264,95 @@ switch_context(uint32_t *prev_sp,
 
 struct process procs[PROCS_MAX]; // All process control structures.
 
-struct process *create_process(uint32_t pc, const void *image,
-                               size_t image_size) {
-  // Find an unused process control structure.
-  struct process *proc = NULL;
-  int i;
-  for (i = 0; i < PROCS_MAX; i++) {
-    if (procs[i].state == PROC_UNUSED) {
-      proc = &procs[i];
-      break;
-    }
+// FNV-1a hash of a program name - run.sh builds the archive index with the
+// same function
+uint32_t program_hash(const char *name) {
+  uint32_t hash = 2166136261u;
+  while (*name) {
+    hash ^= (uint8_t)*name++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+const struct program *find_program(const char *name) {
+  const struct program_archive *archive =
+      (const struct program_archive *)__programs;
+  uint32_t slot = program_hash(name) % PROGRAM_SLOTS;
+  for (int i = 0; i < PROGRAM_SLOTS; i++) { // linear probing
+    uint8_t entry = archive->index[slot];
+    if (entry == 0) // empty slot - not in the archive
+      return NULL;
+
+    const struct program *prog = &archive->programs[entry - 1];
+    if (strcmp(prog->name, name) == 0)
+      return prog;
+    slot = (slot + 1) % PROGRAM_SLOTS;
+  }
+  return NULL;
+}
+
+int next_pid = 1; // pids are never reused, even when slots are
+
+// Find an unused process control structure. Slots of exited processes are
+// reused together with their kernel stack and page table. create_process
+// frees the data, bss and stack pages the exited process touched.
+struct process *alloc_process(void) {
+  for (int i = 0; i < PROCS_MAX; i++) {
+    if (procs[i].state == PROC_UNUSED || procs[i].state == PROC_EXITED)
+      return &procs[i];
   }
+  return NULL;
+}
+
+uint32_t *kstack_table; // 2nd level page table shared by all kernel stacks
+
+// Allocate and map the kernel stack of process slot i. The page below it is
+// left unmapped as a guard.
+void alloc_kstack(struct process *proc, int i) {
+  if (!kstack_table)
+    kstack_table = (uint32_t *)alloc_pages(1);
+
+  paddr_t stack = alloc_pages(KSTACK_PAGES);
+  vaddr_t bottom = KSTACK_BASE + i * KSTACK_SLOT_SIZE + PAGE_SIZE;
+  for (uint32_t offset = 0; offset < KSTACK_SIZE; offset += PAGE_SIZE) {
+    uint32_t vpn0 = ((bottom + offset) >> 12) & 0x3ff;
+    kstack_table[vpn0] =
+        (((stack + offset) / PAGE_SIZE) << 10) | PAGE_R | PAGE_W | PAGE_V;
+  }
+
+  proc->kstack = bottom + KSTACK_SIZE;
+  proc->kstack_paddr = stack;
+}
+
+// Bytes of the kernel stack that have ever been written, found by scanning up
+// from the bottom for the first word that no longer holds the poison pattern.
+uint32_t kstack_peak(struct process *proc) {
+  if (!proc->kstack_paddr)
+    return 0;
+
+  const uint32_t *p = (const uint32_t *)proc->kstack_paddr;
+  const uint32_t *end = p + KSTACK_SIZE / sizeof(uint32_t);
+  while (p < end && *p == KSTACK_POISON * 0x01010101u)
+    p++;
+  return (paddr_t)end - (paddr_t)p;
+}
 
+struct process *create_process(uint32_t pc, const struct program *prog) {
+  struct process *proc = alloc_process();
   if (!proc)
     PANIC("no free process slots");
+  int i = proc - procs;
+
+  if (!proc->kstack) // reused slots keep their stack
+    alloc_kstack(proc, i);
+  memset((void *)proc->kstack_paddr, KSTACK_POISON, KSTACK_SIZE);
 
   // Stack callee-saved registers. These register values will be restored in
-  // the first context switch in switch_context.
-  uint32_t *sp = (uint32_t *)&proc->stack[sizeof(proc->stack)];
+  // the first context switch in switch_context. Written through the physical
+  // address since paging may not be enabled yet.
+  paddr_t stack_top = proc->kstack_paddr + KSTACK_SIZE;
+  uint32_t *sp = (uint32_t *)stack_top;
   *--sp = 0;            // s11
   *--sp = 0;            // s10
   *--sp = 0;            // s9
@@ -269,39 +367,173 @@ struct process *create_process(uint32_t pc, const void *image,
   *--sp = 0;            // s0
   *--sp = (uint32_t)pc; // ra
 
-  uint32_t *page_table = (uint32_t *)alloc_pages(1);
+  uint32_t *page_table = proc->page_table;
+  if (page_table) {
+    // Reused slot: keep the kernel mappings and the 2nd level tables of the
+    // user region, only drop the previous process's user pages
+    for (vaddr_t vaddr = USER_BASE; vaddr < USER_END; vaddr += 1 << 22) {
+      uint32_t vpn1 = (vaddr >> 22) & 0x3ff;
+      if (!(page_table[vpn1] & PAGE_V))
+        continue;
+
+      uint32_t *table0 = (uint32_t *)((page_table[vpn1] >> 10) * PAGE_SIZE);
+      for (int vpn0 = 0; vpn0 < 1024; vpn0++) {
+        // Writable pages are the process's own; text belongs to the archive
+        if ((table0[vpn0] & PAGE_V) && (table0[vpn0] & PAGE_W))
+          free_page((table0[vpn0] >> 10) * PAGE_SIZE);
+      }
+      memset(table0, 0, PAGE_SIZE);
+    }
+  } else {
+    page_table = (uint32_t *)alloc_pages(1);
 
-  // Map kernel pages such that it can access anything
-  for (paddr_t paddr = (paddr_t)__kernel_base; paddr < (paddr_t)__free_ram_end;
-       paddr += PAGE_SIZE) {
-    map_page(page_table, paddr, paddr,
-             PAGE_R | PAGE_W | PAGE_X); // vaddr = paddr
+    // Map kernel pages such that it can access anything
+    for (paddr_t paddr = (paddr_t)__kernel_base;
+         paddr < (paddr_t)__free_ram_end; paddr += PAGE_SIZE) {
+      map_page(page_table, paddr, paddr,
+               PAGE_R | PAGE_W | PAGE_X); // vaddr = paddr
+    }
+
+    // Share the kernel stack mappings of all processes
+    page_table[(KSTACK_BASE >> 22) & 0x3ff] =
+        (((paddr_t)kstack_table / PAGE_SIZE) << 10) | PAGE_V;
   }
 
-  // Map & allocate user pages for user program
-  if (image) {
-    for (uint32_t image_offset = 0; image_offset < image_size;
-         image_offset += PAGE_SIZE) {
-      paddr_t page = alloc_pages(1);
+  memset(&proc->usage, 0, sizeof(proc->usage));
+
+  // User pages are mapped on demand by handle_page_fault
+  if (prog && (!is_aligned((paddr_t)__programs + prog->offset, PAGE_SIZE) ||
+               !is_aligned(prog->text_size, PAGE_SIZE)))
+    PANIC("misaligned program image %s", prog->name);
+  // Text pages are mapped to user mode as is, so they must not reach past the
+  // zero padded end of the archive into kernel data
+  if (prog && prog->offset + prog->text_size >
+                  (size_t)(__programs_end - __programs))
+    PANIC("text of program %s extends past the archive", prog->name);
+  proc->prog = prog;
+  proc->fault_start = proc->fault_end = 0;
+  proc->fault_window = 1;
 
-      // Handle the case where the data to be copied is smaller than the
-      // page size.
-      size_t remaining = image_size - image_offset;
-      size_t copy_size = PAGE_SIZE <= remaining ? PAGE_SIZE : remaining;
+  // Initialize fields.
+  proc->pid = next_pid++;
+  proc->state = PROC_RUNNABLE;
+  proc->sp = proc->kstack - (stack_top - (paddr_t)sp); // same depth, virtual
+  proc->page_table = page_table;
+  return proc;
+}
+
+bool is_mapped(uint32_t *table1, vaddr_t vaddr) {
+  uint32_t vpn1 = (vaddr >> 22) & 0x3ff;
+  if ((table1[vpn1] & PAGE_V) == 0)
+    return false;
 
-      // Fill and map the page.
+  uint32_t *table0 = (uint32_t *)((table1[vpn1] >> 10) * PAGE_SIZE);
+  return table0[(vaddr >> 12) & 0x3ff] & PAGE_V;
+}
+
+// Whether vaddr falls inside the memory image of a user process
+bool in_user_image(struct process *proc, vaddr_t vaddr) {
+  return proc->prog && vaddr >= USER_BASE &&
+         vaddr - USER_BASE < align_up(proc->prog->mem_size, PAGE_SIZE);
+}
+
+// Map the user page at vaddr. Text and read-only data are mapped in place from
+// the kernel image - shared by every process running the program, never
+// copied. Writable data gets a private copy, and bss and the stack are zero
+// filled.
+void map_user_page(struct process *proc, vaddr_t vaddr) {
+  const struct program *prog = proc->prog;
+  const uint8_t *image = (const uint8_t *)__programs + prog->offset;
+  uint32_t image_offset = vaddr - USER_BASE;
+  if (image_offset < prog->text_size) {
+    map_page(proc->page_table, vaddr, (paddr_t)image + image_offset,
+             PAGE_U | PAGE_R | PAGE_X);
+  } else {
+    paddr_t page = alloc_pages(1); // zero filled
+
+    // Handle the case where the data to be copied is smaller than the
+    // page size.
+    if (image_offset < prog->size) {
+      size_t remaining = prog->size - image_offset;
+      size_t copy_size = PAGE_SIZE <= remaining ? PAGE_SIZE : remaining;
       memcpy((void *)page, image + image_offset, copy_size);
-      map_page(page_table, USER_BASE + image_offset, page,
-               PAGE_U | PAGE_R | PAGE_W | PAGE_X);
     }
+    map_page(proc->page_table, vaddr, page, PAGE_U | PAGE_R | PAGE_W);
   }
+  proc->usage.resident_pages++;
+}
 
-  // Initialize fields.
-  proc->pid = i + 1;
-  proc->state = PROC_RUNNABLE;
-  proc->sp = (uint32_t)sp;
-  proc->page_table = page_table;
-  return proc;
+// Demand-map a faulting user page together with a window of its neighbours
+// (fault-around). The window doubles while faults keep landing just past
+// either end of the previous one - sequential access in either direction,
+// e.g. a buffer sweep or a growing stack - and drops back to a single page
+// otherwise. Only pages that cost nothing to map are pulled in early: text
+// already resident in the kernel image, and zero filled bss/stack pages.
+bool handle_page_fault(struct process *proc, vaddr_t vaddr) {
+  vaddr_t page = align_down(vaddr, PAGE_SIZE);
+  if (!in_user_image(proc, vaddr) || is_mapped(proc->page_table, page))
+    return false; // not demand paged, or a permission fault
+
+  bool ascending = page == proc->fault_end;
+  bool descending = page + PAGE_SIZE == proc->fault_start;
+  if (!ascending && !descending)
+    proc->fault_window = 1;
+  else if (proc->fault_window < FAULT_AROUND_MAX)
+    proc->fault_window *= 2;
+
+  vaddr_t start = page, end = page + proc->fault_window * PAGE_SIZE;
+  if (descending && !ascending) {
+    start = page + PAGE_SIZE - proc->fault_window * PAGE_SIZE;
+    end = page + PAGE_SIZE;
+  }
+
+  // Clip the window to the image
+  vaddr_t image_end = USER_BASE + align_up(proc->prog->mem_size, PAGE_SIZE);
+  if (start < USER_BASE || start > page) // also catches wrap-around
+    start = USER_BASE;
+  if (end > image_end)
+    end = image_end;
+
+  for (vaddr_t addr = start; addr < end; addr += PAGE_SIZE) {
+    uint32_t image_offset = addr - USER_BASE;
+    bool copied = image_offset >= proc->prog->text_size &&
+                  image_offset < proc->prog->size; // private data copy
+    if (addr == page || (!copied && !is_mapped(proc->page_table, addr)))
+      map_user_page(proc, addr);
+  }
+
+  proc->fault_start = start;
+  proc->fault_end = end;
+  __asm__ __volatile__("sfence.vma"); // drop any cached invalid entries
+  return true;
+}
+
+// Whether [vaddr, vaddr + len) lies inside the memory image of a user
+// process. Syscalls must check every user pointer with this before touching
+// it: SSTATUS_SUM lets the kernel dereference anything, and kernel pages are
+// writable from S-mode.
+bool is_user_range(struct process *proc, vaddr_t vaddr, size_t len,
+                   bool writable) {
+  if (len == 0)
+    return true;
+  if (vaddr + len < vaddr || !in_user_image(proc, vaddr) ||
+      !in_user_image(proc, vaddr + len - 1))
+    return false;
+  if (writable && vaddr - USER_BASE < proc->prog->text_size)
+    return false; // text is mapped read-only
+  return true;
+}
+
+// Map [vaddr, vaddr + len) before the kernel touches it on behalf of a
+// process. kernel_entry can't take a page fault from S-mode, so syscalls must
+// not rely on demand paging. The range must pass is_user_range first.
+void populate_user(struct process *proc, vaddr_t vaddr, size_t len) {
+  for (vaddr_t page = align_down(vaddr, PAGE_SIZE); page < vaddr + len;
+       page += PAGE_SIZE) {
+    if (!is_mapped(proc->page_table, page))
+      map_user_page(proc, page);
+  }
+  __asm__ __volatile__("sfence.vma");
 }
 
 void delay(void) { // busy waiting
@@ -315,12 +547,14 @@ struct process *proc_c;
 
 struct process *current_proc; // currently running process
 struct process *idle_proc; // process to run if there are no runnable processes
+uint64_t switch_cycles;    // cycle count when current_proc was switched in
 
 void yield(void) {
   // Search for a runnable process
   struct process *next = idle_proc;
-  for (int i = 0; i < PROCS_MAX; i++) {
-    struct process *proc = &procs[(current_proc->pid + i) % PROCS_MAX];
+  int current = current_proc - procs;
+  for (int i = 1; i <= PROCS_MAX; i++) { // round robin, starting after current
+    struct process *proc = &procs[(current + i) % PROCS_MAX];
     if (proc->state == PROC_RUNNABLE && proc->pid > 0) {
       next = proc;
       break;
@@ -340,9 +574,13 @@ void yield(void) {
       :
       : [satp] "r"(SATP_SV32 | ((uint32_t)next->page_table /
                                 PAGE_SIZE)), // PPN bits in satp register 21-0
-        [sscratch] "r"((uint32_t)&next->stack[sizeof(
-            next->stack)])); // store TOS of next process to help in exception
-                             // handling
+        [sscratch] "r"(next->kstack)); // store TOS of next process to help in
+                                       // exception handling
+
+  // Charge the outgoing process for the cycles it ran
+  uint64_t now = read_cycles();
+  current_proc->usage.cycles += now - switch_cycles;
+  switch_cycles = now;
 
   // Context switch
   struct process *prev = current_proc;
@@ -372,7 +610,43 @@ void proc_b_entry(void) { // process B entrypoint
   }
 }
 
+int console_flags = CONSOLE_ECHO | CONSOLE_LINE; // console line discipline
+
+// Read from the console into buf. In line mode, returns after a newline or
+// once buf is full, so a whole line costs a single syscall instead of one per
+// character. In raw mode, blocks only for the first byte and then returns
+// whatever has already arrived, letting scripts be read in bulk.
+int console_read(char *buf, int n) {
+  int i = 0;
+  while (i < n) {
+    long ch = getchar();
+    if (ch < 0) {
+      if (i > 0 && !(console_flags & CONSOLE_LINE))
+        break; // raw mode: hand over what we have so far
+      yield(); // don't block CPU while taking input
+      continue;
+    }
+
+    if (console_flags & CONSOLE_ECHO) {
+      putchar(ch);
+      if (ch == '\r')
+        putchar('\n');
+    }
+
+    if (ch == '\r') // serial console sends CR on enter
+      ch = '\n';
+
+    buf[i++] = ch;
+    if (ch == '\n' && (console_flags & CONSOLE_LINE))
+      break;
+  }
+  return i;
+}
+
 void handle_syscall(struct trap_frame *frame) {
+  if (frame->a3 < SYS_MAX)
+    current_proc->usage.syscalls[frame->a3]++;
+
   switch (frame->a3) {
   case SYS_EXIT:
     printf("process %d exited\n", current_proc->pid);
@@ -392,6 +666,85 @@ void handle_syscall(struct trap_frame *frame) {
   case SYS_PUTCHAR:
     putchar(frame->a0);
     break;
+  case SYS_READ: {
+    int fd = frame->a0;
+    char *buf = (char *)frame->a1;
+    int len = frame->a2;
+    if (fd != 0 || len < 0 || // only the console (stdin) is readable
+        !is_user_range(current_proc, (vaddr_t)buf, len, true)) {
+      frame->a0 = -1;
+      break;
+    }
+
+    populate_user(current_proc, (vaddr_t)buf, len);
+    frame->a0 = console_read(buf, len);
+    break;
+  }
+  case SYS_CONSOLE_MODE: { // returns previous flags
+    int prev = console_flags;
+    console_flags = frame->a0;
+    frame->a0 = prev;
+    break;
+  }
+  case SYS_YIELD:
+    yield();
+    break;
+  case SYS_SPAWN: { // a0 = program name, returns pid or -1
+    const char *user_name = (const char *)frame->a0;
+    vaddr_t image_end =
+        USER_BASE + align_up(current_proc->prog->mem_size, PAGE_SIZE);
+    size_t name_size = PROGRAM_NAME_MAX; // don't run past the image end
+    if (image_end - (vaddr_t)user_name < name_size)
+      name_size = image_end - (vaddr_t)user_name;
+    if (!is_user_range(current_proc, (vaddr_t)user_name, name_size, false)) {
+      frame->a0 = -1;
+      break;
+    }
+    populate_user(current_proc, (vaddr_t)user_name, name_size);
+
+    // Only the checked bytes may be read - a fault here would clobber the
+    // kernel stack
+    char name[PROGRAM_NAME_MAX];
+    size_t len = 0;
+    while (len < name_size && user_name[len]) {
+      name[len] = user_name[len];
+      len++;
+    }
+    if (len == name_size) { // no terminator - too long or runs off the image
+      frame->a0 = -1;
+      break;
+    }
+    name[len] = '\0';
+
+    const struct program *prog = find_program(name);
+    if (!prog || !alloc_process()) {
+      frame->a0 = -1;
+      break;
+    }
+
+    frame->a0 = create_process((uint32_t)user_entry, prog)->pid;
+    break;
+  }
+  case SYS_PROC_STAT: { // a0 = process slot or -1 for self, a1 = stat
+    int slot = frame->a0;
+    struct proc_stat *stat = (struct proc_stat *)frame->a1;
+    if (slot >= PROCS_MAX || slot < -1 ||
+        !is_user_range(current_proc, (vaddr_t)stat, sizeof(*stat), true)) {
+      frame->a0 = -1;
+      break;
+    }
+    populate_user(current_proc, (vaddr_t)stat, sizeof(*stat));
+
+    struct process *proc = slot < 0 ? current_proc : &procs[slot];
+    stat->pid = proc->pid;
+    stat->state = proc->state;
+    stat->kstack_peak = kstack_peak(proc);
+    stat->usage = proc->usage;
+    if (proc == current_proc) // include the time slice still in progress
+      stat->usage.cycles += read_cycles() - switch_cycles;
+    frame->a0 = 0;
+    break;
+  }
   default:
     PANIC("unexpected syscall a3=%x\n", frame->a3);
   }
@@ -403,9 +756,38 @@ void handle_trap(
   uint32_t scause = READ_CSR(scause);
   uint32_t stval = READ_CSR(stval);
   uint32_t user_pc = READ_CSR(sepc);
+  uint32_t sstatus = READ_CSR(sstatus);
+
+  // The frame must sit inside the current kernel stack, otherwise sscratch or
+  // the stack itself has been corrupted
+  if ((vaddr_t)frame < current_proc->kstack - KSTACK_SIZE ||
+      (vaddr_t)frame + sizeof(*frame) > current_proc->kstack)
+    PANIC("trap frame %x outside kernel stack of process %d", (vaddr_t)frame,
+          current_proc->pid);
+
   if (scause == SCAUSE_ECALL) {
     handle_syscall(frame);
     user_pc += 4;
+  } else if (scause == SCAUSE_INST_PAGE_FAULT ||
+             scause == SCAUSE_LOAD_PAGE_FAULT ||
+             scause == SCAUSE_STORE_PAGE_FAULT) {
+    current_proc->usage.page_faults++;
+
+    // Demand paging is for user code only: syscalls populate user buffers
+    // up front, so a fault taken in S-mode is a kernel bug
+    if (sstatus & SSTATUS_SPP) {
+      if (stval >= KSTACK_BASE &&
+          stval < KSTACK_BASE + PROCS_MAX * KSTACK_SLOT_SIZE)
+        PANIC("kernel stack overflow in process %d: stval=%x, sepc=%x",
+              current_proc->pid, stval, user_pc);
+      PANIC("kernel fault on user address scause=%x, stval=%x, sepc=%x\n",
+            scause, stval, user_pc);
+    }
+
+    // Retry the faulting instruction once the page is mapped
+    if (!handle_page_fault(current_proc, stval))
+      PANIC("unexpected page fault scause=%x, stval=%x, sepc=%x\n", scause,
+            stval, user_pc);
   } else {
     PANIC("unexpected trap scause=%x, stval=%x, sepc=%x\n", scause, stval,
           user_pc);
@@ -420,6 +802,7 @@ void kernel_main(void) { // what to be done by kernel
   WRITE_CSR( // placement is important to catch exceptions
       stvec,
       (uint32_t)kernel_entry); // register exception handler in stvec register
+  WRITE_CSR(scounteren, 0x7); // let U-mode read cycle, time and instret
   // __asm__ __volatile__("unimp"); // trigger illegal instruction
 
 #ifdef DEBUG
@@ -434,19 +817,24 @@ void kernel_main(void) { // what to be done by kernel
 #endif /* ifdef DEBUG */
 
   printf("\nBOOTED OS!\n");
-  idle_proc = create_process((uint32_t)NULL, NULL, 0);
+  if (((struct program_archive *)__programs)->magic != PROGRAM_MAGIC)
+    PANIC("bad program archive");
+
+  idle_proc = create_process((uint32_t)NULL, NULL);
   idle_proc->pid = -1; // idle
   current_proc =
       idle_proc; // ensures execution context of boot process is saved and
                  // restored when all processes finish execution
+  switch_cycles = read_cycles();
 
 #ifdef TEST
-  proc_a = create_process((uint32_t)proc_a_entry, NULL, 0); // kernel process
-  proc_b = create_process((uint32_t)proc_b_entry, NULL, 0); // kernel process
-#endif                                                      /* ifdef TEST */
-  proc_c = create_process((uint32_t)user_entry,
-                          _binary_shell_bin_start, // user process (shell)
-                          (size_t)_binary_shell_bin_size);
+  proc_a = create_process((uint32_t)proc_a_entry, NULL); // kernel process
+  proc_b = create_process((uint32_t)proc_b_entry, NULL); // kernel process
+#endif                                                  /* ifdef TEST */
+  const struct program *shell = find_program("shell");
+  if (!shell)
+    PANIC("shell not found in program archive");
+  proc_c = create_process((uint32_t)user_entry, shell); // user process (shell)
   yield();
 
   PANIC("switched to idle process");
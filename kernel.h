@@ -61,20 +61,59 @@ struct trap_frame {
   uint32_t sp;
 } __attribute__((packed));
 
-#define PROCS_MAX 8 // Maximum number of processes
+// kernel_entry pushes 31 registers - keep the assembly in sync
+_Static_assert(sizeof(struct trap_frame) == 4 * 31, "trap_frame size mismatch");
 
-#define PROC_UNUSED 0   // Unused process control structure
-#define PROC_RUNNABLE 1 // Runnable process
-#define PROC_EXITED 2   // Exited process
+// Kernel stacks live in their own virtual region, shared by every page table
+// through a single 2nd level table. Each process slot gets an unmapped guard
+// page followed by its stack, so an overflow faults instead of silently
+// corrupting the neighbouring process.
+#define KSTACK_BASE 0x40000000 // must not overlap user or kernel mappings
+#define KSTACK_PAGES 2         // Kernel stack of the process - 8KB
+#define KSTACK_SIZE (KSTACK_PAGES * PAGE_SIZE)
+#define KSTACK_SLOT_SIZE (PAGE_SIZE + KSTACK_SIZE) // guard page + stack
+#define KSTACK_POISON 0x5a // fill byte used to find the stack high-water mark
+_Static_assert(PROCS_MAX * KSTACK_SLOT_SIZE <= 4 * 1024 * 1024,
+               "kernel stacks must fit in one 2nd level page table");
 
 struct process {
-  int pid;              // Process ID
-  int state;            // Process state: PROC_UNUSED or PROC_RUNNABLE
-  vaddr_t sp;           // Stack pointer pointing to kernel stack
-  uint8_t stack[8192];  // Kernel stack of the process - 8KB
-  uint32_t *page_table; // pointer to 1st level page table
+  int pid;                    // Process ID
+  int state;                  // Process state: PROC_UNUSED or PROC_RUNNABLE
+  vaddr_t sp;                 // Stack pointer pointing to kernel stack
+  vaddr_t kstack;             // Top of the kernel stack (virtual address)
+  paddr_t kstack_paddr;       // Bottom of the kernel stack (physical address)
+  uint32_t *page_table;       // pointer to 1st level page table
+  struct proc_usage usage;    // resource accounting
+  const struct program *prog; // image backing the user pages, NULL if kernel
+  vaddr_t fault_start;        // previous fault-around window [start, end)
+  vaddr_t fault_end;
+  uint32_t fault_window;      // pages to map on the next page fault
 };
 
+#define PROGRAM_MAGIC 0x4d524750 // "PGRM" - start of the program archive
+#define PROGRAM_SLOTS 16         // hash index size - must match run.sh
+#define PROGRAM_NAME_MAX 16      // including the NULL terminator
+
+// An executable user program embedded in the kernel image
+struct program {
+  char name[PROGRAM_NAME_MAX];
+  uint32_t offset;    // image offset from the start of the archive
+  uint32_t size;      // image size in bytes
+  uint32_t text_size; // page-aligned size of text and read-only data
+  uint32_t mem_size;  // size in memory, including bss and the user stack
+};
+
+// Read-only archive of user programs built by run.sh. Images follow the
+// entries, each aligned to a page boundary.
+struct program_archive {
+  uint32_t magic;
+  uint32_t count;
+  uint8_t index[PROGRAM_SLOTS]; // name hash slot -> entry number + 1, 0 = empty
+  struct program programs[];
+};
+
+#define FAULT_AROUND_MAX 32 // most pages mapped by a single page fault
+
 #define SATP_SV32 (1u << 31) // 32bit unsigned int - bit 31 = 1 - satp register
 #define PAGE_V (1 << 0)      // "Valid" bit (entry is enabled) - flags
 #define PAGE_R (1 << 1)      // Readable
@@ -83,4 +122,9 @@ struct process {
 #define PAGE_U (1 << 4)      // User (accessible in user mode)
 
 #define SSTATUS_SPIE (1 << 5) // switch mode from S to U
+#define SSTATUS_SPP (1 << 8)  // trap was taken from S-mode
+#define SSTATUS_SUM (1 << 18) // allow S-mode to access U-mode pages
 #define SCAUSE_ECALL 8        // environment call from U-mode
+#define SCAUSE_INST_PAGE_FAULT 12  // instruction fetch page fault
+#define SCAUSE_LOAD_PAGE_FAULT 13  // load page fault
+#define SCAUSE_STORE_PAGE_FAULT 15 // store/AMO page fault
@@ -8,17 +8,76 @@ BIOS='./opensbi-riscv32-generic-fw_dynamic_v1.5.1.bin'
 # Path to clang and compiler flags
 CC=clang
 OBJCOPY=llvm-objcopy
+NM=llvm-nm
 CFLAGS="-std=c11 -O2 -g3 -Wall -Wextra --target=riscv32 -ffreestanding -nostdlib"
 
-# Build the shell (application)
-$CC $CFLAGS -Wl,-Tuser.ld -Wl,-Map=shell.map -o shell.elf \
-  shell.c user.c common.c
-$OBJCOPY --set-section-flags .bss=alloc,contents -O binary shell.elf shell.bin # convert to raw binary format
-$OBJCOPY -Ibinary -Oelf32-littleriscv shell.bin shell.bin.o                    # convert to c-embeddable format
+# User programs packed into the kernel image - each is built from <name>.c
+PROGRAMS=(shell hello spin sweep)
+PROGRAM_SLOTS=16            # must match PROGRAM_SLOTS in kernel.h
+PROGRAM_MAGIC=0x4d524750    # "PGRM" - must match PROGRAM_MAGIC in kernel.h
+USER_BASE=0x1000000         # must match user.ld
+
+# FNV-1a hash of a program name - must match program_hash() in kernel.c
+hash_name() {
+  local name=$1 hash=2166136261 i ch
+  for ((i = 0; i < ${#name}; i++)); do
+    printf -v ch '%d' "'${name:i:1}"
+    hash=$((((hash ^ ch) * 16777619) & 0xffffffff))
+  done
+  echo $hash
+}
+
+# Emit the program archive (struct program_archive) as assembly: header, hash
+# index and entries, followed by the page-aligned images so the kernel can map
+# their text pages in place
+pack_programs() {
+  local index=() i slot text_end mem_end
+  for ((i = 0; i < PROGRAM_SLOTS; i++)); do
+    index[i]=0
+  done
+  for i in "${!PROGRAMS[@]}"; do # open addressing with linear probing
+    slot=$(($(hash_name "${PROGRAMS[i]}") % PROGRAM_SLOTS))
+    while ((index[slot] != 0)); do
+      slot=$(((slot + 1) % PROGRAM_SLOTS))
+    done
+    index[slot]=$((i + 1)) # 0 marks an empty slot
+  done
+
+  echo '.section .rodata.programs, "a"'
+  echo '.balign 4096'
+  echo '.global __programs'
+  echo '__programs:'
+  echo ".word $PROGRAM_MAGIC, ${#PROGRAMS[@]}"
+  echo ".byte $(IFS=,; echo "${index[*]}")"
+  for i in "${!PROGRAMS[@]}"; do
+    text_end=$($NM "${PROGRAMS[i]}.elf" | awk '$3 == "__data_start" { print $1 }')
+    mem_end=$($NM "${PROGRAMS[i]}.elf" | awk '$3 == "__stack_top" { print $1 }')
+    echo "name_$i: .asciz \"${PROGRAMS[i]}\""
+    echo ".fill 16 - (. - name_$i)" # PROGRAM_NAME_MAX
+    echo ".word image_$i - __programs, image_${i}_end - image_$i"
+    echo ".word 0x$text_end - $USER_BASE, 0x$mem_end - $USER_BASE"
+  done
+  for i in "${!PROGRAMS[@]}"; do
+    echo '.balign 4096'
+    echo "image_$i: .incbin \"${PROGRAMS[i]}.bin\""
+    echo "image_${i}_end:"
+  done
+  echo '.balign 4096' # zero pad the last text page - kernel data follows
+  echo '.global __programs_end'
+  echo '__programs_end:'
+}
+
+# Build the user programs (applications)
+for prog in "${PROGRAMS[@]}"; do
+  $CC $CFLAGS -Wl,-Tuser.ld -Wl,-Map=$prog.map -o $prog.elf \
+    $prog.c user.c common.c
+  $OBJCOPY -O binary $prog.elf $prog.bin # convert to raw binary format - bss is zero filled on demand
+done
+pack_programs >programs.S # pack all programs into one embeddable archive
 
 # Build the kernel
 $CC $CFLAGS -Wl,-Tkernel.ld -Wl,-Map=kernel.map -o kernel.elf \
-  kernel.c common.c shell.bin.o # embed shell.bin.o into kernel
+  kernel.c common.c programs.S # embed the program archive into kernel
 
 # Start QEMU
 $QEMU -machine virt -bios $BIOS -nographic -serial mon:stdio --no-reboot \
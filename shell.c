@@ -2,6 +2,243 @@
 #undef DEBUG
 #undef TEST
 
+struct command {
+  const char *name;
+  void (*handler)(const char *args);
+};
+
+void cmd_hello(const char *args) {
+  (void)args;
+  printf("Hello World from shell!\n");
+}
+
+void cmd_echo(const char *args) { printf("%s\n", args); }
+
+void cmd_exit(const char *args) {
+  (void)args;
+  exit();
+}
+
+void cmd_run(const char *args) {
+  int pid = spawn(args);
+  if (pid < 0) {
+    printf("run: cannot spawn %s\n", args);
+    return;
+  }
+  printf("started %s as process %d\n", args, pid);
+}
+
+void cmd_batch(const char *args);
+void cmd_top(const char *args);
+
+// Perfect hash over the built-in command names: first char + last char +
+// length, masked to the table size. Every built-in lands in its own slot, so a
+// lookup is one hash and one strcmp. Re-check for collisions when adding one.
+#define COMMANDS_MAX 16
+#define COMMAND_HASH(name, len)                                                \
+  (((uint8_t)(name)[0] + (uint8_t)(name)[(len) - 1] + (len)) &                 \
+   (COMMANDS_MAX - 1))
+
+static const struct command commands[COMMANDS_MAX] = {
+    [3] = {"run", cmd_run},      // ('r' + 'n' + 3) & 15
+    [7] = {"top", cmd_top},      // ('t' + 'p' + 3) & 15
+    [8] = {"echo", cmd_echo},    // ('e' + 'o' + 4) & 15
+    [12] = {"hello", cmd_hello}, // ('h' + 'o' + 5) & 15
+    [13] = {"exit", cmd_exit},   // ('e' + 't' + 4) & 15
+    [15] = {"batch", cmd_batch}, // ('b' + 'h' + 5) & 15
+};
+
+void run_command(char *cmdline, int len) {
+  // Split the line into the command name and its arguments
+  const char *args = "";
+  char *space = memchr(cmdline, ' ', len);
+  if (space) {
+    *space = '\0';
+    args = space + 1;
+    len = space - cmdline;
+  }
+
+  if (len == 0) // empty line
+    return;
+
+  const struct command *cmd = &commands[COMMAND_HASH(cmdline, len)];
+  if (cmd->name && strcmp(cmd->name, cmdline) == 0) {
+    cmd->handler(args);
+  } else {
+    printf("unknown command: %s\n", cmdline);
+  }
+}
+
+#define TICKS_PER_US (TIMER_FREQ / 1000000)
+
+int parse_int(const char *s) {
+  int value = 0;
+  while (*s >= '0' && *s <= '9')
+    value = value * 10 + (*s++ - '0');
+  return value;
+}
+
+// Share of whole taken by part, in percent. There is no libgcc for 64-bit
+// division, so both are scaled down until whole fits in 32 bits.
+int percent(uint64_t part, uint64_t whole) {
+  while (whole >> 32) {
+    part >>= 1;
+    whole >>= 1;
+  }
+
+  uint32_t hundredth = (uint32_t)whole / 100;
+  return hundredth ? (uint32_t)part / hundredth : 0;
+}
+
+// Show per-process resource usage, refreshed every second. CPU% is the share
+// of cycles each process used since the previous refresh. The optional
+// argument is the number of refreshes (default 5).
+void cmd_top(const char *args) {
+  int rounds = *args ? parse_int(args) : 5;
+
+  // Baseline sample, so the first refresh covers one interval too
+  int pids[PROCS_MAX];
+  uint64_t prev_cycles[PROCS_MAX];
+  for (int i = 0; i < PROCS_MAX; i++) {
+    struct proc_stat stat;
+    proc_stat(i, &stat);
+    pids[i] = stat.pid;
+    prev_cycles[i] = stat.usage.cycles;
+  }
+
+  for (int round = 0; round < rounds; round++) {
+    // Let the other processes run while we wait
+    uint32_t start = rdtime();
+    while (rdtime() - start < TIMER_FREQ)
+      yield();
+
+    struct proc_stat stats[PROCS_MAX];
+    uint64_t deltas[PROCS_MAX];
+    uint64_t total = 0;
+    for (int i = 0; i < PROCS_MAX; i++) {
+      proc_stat(i, &stats[i]);
+      if (stats[i].pid != pids[i]) { // slot reused - count from its creation
+        pids[i] = stats[i].pid;
+        prev_cycles[i] = 0;
+      }
+      deltas[i] = stats[i].usage.cycles - prev_cycles[i];
+      prev_cycles[i] = stats[i].usage.cycles;
+      total += deltas[i];
+    }
+
+    printf("\033[H\033[2J"); // clear the terminal
+    printf("PID\tSTATE\tCPU%%\tSYSCALLS\tFAULTS\tRSS(KB)\tKSTACK\n");
+    for (int i = 0; i < PROCS_MAX; i++) {
+      struct proc_stat *stat = &stats[i];
+      if (stat->state == PROC_UNUSED)
+        continue;
+
+      uint32_t syscalls = 0;
+      for (int j = 0; j < SYS_MAX; j++)
+        syscalls += stat->usage.syscalls[j];
+
+      printf("%d\t%s\t%d\t%d\t\t%d\t%d\t%d\n", stat->pid,
+             stat->state == PROC_RUNNABLE ? "run" : "exit",
+             percent(deltas[i], total), syscalls, stat->usage.page_faults,
+             stat->usage.resident_pages * (PAGE_SIZE / 1024),
+             stat->kstack_peak);
+    }
+  }
+}
+
+// Console input that was read ahead but not consumed yet, e.g. commands piped
+// in behind a batch script's "end" line
+char input[4096];
+int input_len;
+
+// Read one line like read() does in line mode, handing out buffered input
+// before going back to the console
+int read_line(char *line, int size) {
+  int len = 0;
+  if (input_len > 0) {
+    char *newline = memchr(input, '\n', input_len);
+    len = newline ? newline + 1 - input : input_len;
+    if (len > size)
+      len = size;
+    memcpy(line, input, len);
+    input_len -= len;
+    memmove(input, input + len, input_len);
+    if (line[len - 1] == '\n' || len == size)
+      return len;
+  }
+
+  int n = read(0, line + len, size - len); // one syscall per line
+  return n < 0 ? n : len + n;
+}
+
+// Run a script piped over the console until a line reading "end". Echo is off
+// and input is read in raw chunks, so commands run back-to-back at console
+// bandwidth instead of keystroke pace. Each command reports its runtime.
+// Anything read past the "end" line is left in input for the shell.
+void cmd_batch(const char *args) {
+  (void)args;
+  static bool in_batch = false;
+  if (in_batch) { // nested batch would steal the buffered script
+    printf("batch: already in batch mode\n");
+    return;
+  }
+
+  in_batch = true;
+  int prev_mode = console_mode(0); // raw, no echo
+  int count = 0;
+  uint32_t total_us = 0;
+  bool end = false;
+  bool skipping = false; // dropping the rest of an overlong line
+  while (!end) {
+    if (input_len == sizeof(input)) { // a full buffer without a newline
+      printf("batch: line too long\n");
+      input_len = 0;
+      skipping = true;
+    }
+    if (!memchr(input, '\n', input_len)) { // buffered lines go first
+      int n = read(0, input + input_len, sizeof(input) - input_len);
+      if (n < 0) {
+        printf("batch: read failed\n");
+        break;
+      }
+      input_len += n;
+    }
+
+    char *line = input;
+    char *newline;
+    if (skipping) {
+      if (!(newline = memchr(line, '\n', input_len))) {
+        input_len = 0;
+        continue;
+      }
+      line = newline + 1;
+      skipping = false;
+    }
+    while (!end && (newline = memchr(line, '\n', input + input_len - line))) {
+      *newline = '\0';
+      end = strcmp(line, "end") == 0;
+      if (!end && newline > line) { // skip empty lines
+        uint32_t start = rdtime();
+        run_command(line, newline - line);
+        uint32_t us = (rdtime() - start) / TICKS_PER_US;
+        printf("[%d us]\n", us);
+        total_us += us;
+        count++;
+      }
+      line = newline + 1;
+    }
+
+    // Move the trailing partial line, or whatever followed "end", to the
+    // front of the buffer
+    input_len = input + input_len - line;
+    memmove(input, line, input_len);
+  }
+
+  console_mode(prev_mode);
+  in_batch = false;
+  printf("batch: %d commands in %d us\n", count, total_us);
+}
+
 void main(void) {
 #ifdef TEST
   *((volatile int *)0x80300000) =
@@ -21,32 +258,17 @@ void main(void) {
 #endif                                       /* ifdef TEST */
 
   while (1) {
-  prompt:
     printf("> ");
     char cmdline[128];
-    for (int i = 0;; i++) {
-      char ch = getchar();
-      putchar(ch);
-      if (i == sizeof(cmdline) - 1) {
-        printf("command line too long\n");
-        goto prompt;
-      } else if (ch == '\r') {
-        printf("\n");
-        cmdline[i] = '\0';
-        break;
-      } else {
-        cmdline[i] = ch;
-      }
+    int len = read_line(cmdline, sizeof(cmdline) - 1);
+    if (len <= 0 || cmdline[len - 1] != '\n') {
+      printf("command line too long\n");
+      while (len > 0 && cmdline[len - 1] != '\n') // discard rest of the line
+        len = read_line(cmdline, sizeof(cmdline) - 1);
+      continue;
     }
 
-    if (strcmp(cmdline, "hello") == 0) {
-      printf("Hello World from shell!\n");
-    } else if (strncmp(cmdline, "echo", 4) == 0) {
-      printf("%s\n", cmdline + 5);
-    } else if (strcmp(cmdline, "exit") == 0) {
-      exit();
-    } else {
-      printf("unknown command: %s\n", cmdline);
-    }
+    cmdline[len - 1] = '\0'; // replace newline
+    run_command(cmdline, len - 1);
   }
 }
@@ -0,0 +1,14 @@
+#include "user.h"
+
+// CPU-bound workload for load tests: burns cycles in slices, yielding to the
+// other processes in between, then exits.
+#define SLICES 1000
+#define SLICE_ITERATIONS 100000
+
+void main(void) {
+  for (int i = 0; i < SLICES; i++) {
+    for (int j = 0; j < SLICE_ITERATIONS; j++)
+      __asm__ __volatile__("nop");
+    yield();
+  }
+}
@@ -25,6 +25,21 @@ __attribute__((noreturn)) void exit(void) {
 
 void putchar(char ch) { syscall(SYS_PUTCHAR, ch, 0, 0); }
 int getchar(void) { return syscall(SYS_GETCHAR, 0, 0, 0); }
+int read(int fd, char *buf, int n) {
+  return syscall(SYS_READ, fd, (int)buf, n);
+}
+int console_mode(int flags) { return syscall(SYS_CONSOLE_MODE, flags, 0, 0); }
+void yield(void) { syscall(SYS_YIELD, 0, 0, 0); }
+int proc_stat(int slot, struct proc_stat *stat) {
+  return syscall(SYS_PROC_STAT, slot, (int)stat, 0);
+}
+int spawn(const char *name) { return syscall(SYS_SPAWN, (int)name, 0, 0); }
+
+uint32_t rdtime(void) { // low 32 bits of the timer - enough for differences
+  uint32_t time;
+  __asm__ __volatile__("rdtime %0" : "=r"(time));
+  return time;
+}
 
 __attribute__((section(".text.start"))) __attribute__((naked)) void
 start(void) {
@@ -4,3 +4,11 @@
 __attribute__((noreturn)) void exit(void);
 void putchar(char ch);
 int getchar(void);
+int read(int fd, char *buf, int n);
+int console_mode(int flags);
+uint32_t rdtime(void);
+void yield(void);
+int proc_stat(int slot, struct proc_stat *stat); // slot -1 = self
+int spawn(const char *name);
+
+#define TIMER_FREQ 10000000 // QEMU virt timebase - 10MHz